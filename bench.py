@@ -12,7 +12,7 @@ def calculate_speedup(run_log_name: str) -> None:
                 break
             if name[0] == "#":
                 print(name)
-                break
+                continue
 
             ref = float(f.readline().split(' ')[-1])
 
@@ -6,15 +6,14 @@
 // A Label indicates one possible way to arrive to a NodeID in the graph. A single NodeID
 // can have many labels associated with it, indicating different parent nodes, total travel
 // time to reach the node, amount of charging time, and state of the battery upon arrival.
+//
+// All criteria are integers, members are ordered largest first to keep the struct compact.
 struct Label {
   Label(NodeID node_id, int label_id, Weight total_weight, Weight charge_time,
-        Kilometers state_of_charge, NodeID parent)
-      : node_id(node_id), label_id(label_id), total_weight(total_weight), charge_time(charge_time),
-        state_of_charge(state_of_charge), parent(parent) {}
+        Millimeters state_of_charge, NodeID parent)
+      : label_id(label_id), total_weight(total_weight), charge_time(charge_time),
+        state_of_charge(state_of_charge), node_id(node_id), parent(parent) {}
 
-  // Non-unique between Labels, references the index into network_ where lat/lng/name info is
-  // stored.
-  NodeID node_id;
   // A unique identifier for this label (node_id is not unique).
   int label_id;
   // Total travel time from the search source to this node.
@@ -22,17 +21,32 @@ struct Label {
   // The amount of time spent charging at the _parent_ node.
   Weight charge_time;
   // The amount of charge remaining when arriving at this node.
-  Kilometers state_of_charge;
+  Millimeters state_of_charge;
+  // Non-unique between Labels, references the index into network_ where lat/lng/name info is
+  // stored.
+  NodeID node_id;
   // The node visited immediately prior.
   NodeID parent;
 
-  bool operator<(const Label &other) const { return total_weight < other.total_weight; }
+  // Orders by total_weight, ties prefer more remaining charge and then the earliest created label
+  // so the search settles nodes in the same order on every platform.
+  bool operator<(const Label &other) const {
+    if (total_weight != other.total_weight) {
+      return total_weight < other.total_weight;
+    }
+    if (state_of_charge != other.state_of_charge) {
+      return state_of_charge > other.state_of_charge;
+    }
+    return label_id < other.label_id;
+  }
 
-  bool operator>(const Label &other) const { return total_weight > other.total_weight; }
+  bool operator>(const Label &other) const { return other < *this; }
 
-  // Returns true if this Label is better on both time and charge criteria over another.
+  // Returns true if this Label is at least as good on both time and charge criteria as another.
+  // Labels equal on both criteria are interchangeable, so the first one kept in a bag absorbs the
+  // rest.
   bool dominates(const Label &other) const {
-    return total_weight < other.total_weight && state_of_charge > other.state_of_charge;
+    return total_weight <= other.total_weight && state_of_charge >= other.state_of_charge;
   }
 
   // Debugging helper to show contents.
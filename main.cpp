@@ -15,7 +15,10 @@ int main(int argc, char **argv) {
     return -1;
   }
 
-  Router routing_engine = Router(network);
+  // Upper bound pruning needs no preprocessing, so it pays off even for a single query.
+  RouterOptions options;
+  options.prune_with_upper_bound = true;
+  Router routing_engine = Router(network, options);
   std::string result = routing_engine.route(initial_charger_name, goal_charger_name);
   std::cout << result << std::endl;
 
@@ -9,11 +9,56 @@ using MinHeapPriorityQueue =
     std::priority_queue<Label, std::vector<Label>, std::greater<std::vector<Label>::value_type>>;
 
 std::string Router::route(std::string source_name, std::string target_name) {
+  stats_ = SearchStats();
+
+  NodeID source_node_id = node_name_map_[source_name];
+  NodeID target_node_id = node_name_map_[target_name];
+
+  NodeToLabelMap shortest_path_tree;
+  if (prune_with_upper_bound_) {
+    shortest_path_tree = pruned_search(source_node_id, target_node_id);
+  } else {
+    shortest_path_tree =
+        search(source_node_id, target_node_id, NO_UPPER_BOUND, std::vector<Kilometers>());
+  }
+
+  stats_.route_weight = shortest_path_tree.at(target_node_id).total_weight;
+  return build_result_string(shortest_path_tree, source_node_id, target_node_id);
+}
+
+NodeToLabelMap Router::pruned_search(NodeID source_node_id, NodeID target_node_id) {
+  std::vector<Kilometers> dist_to_target;
+  const Station &target_station = network_.at(target_node_id);
+  for (const Station &station : network_) {
+    dist_to_target.push_back(
+        haversine_dist(station.lat, station.lon, target_station.lat, target_station.lon));
+  }
+
+  NodeToLabelMap greedy_route;
+  Weight upper_bound =
+      greedy_upper_bound(source_node_id, target_node_id, dist_to_target, greedy_route);
+
+  NodeToLabelMap shortest_path_tree =
+      search(source_node_id, target_node_id, upper_bound, dist_to_target);
+
+  // The search only keeps the first label to reach each node, so on rare occasions the greedy
+  // route beats anything it can find and every route to the target gets pruned.
+  if (shortest_path_tree.count(target_node_id) == 0) {
+    return greedy_route;
+  }
+
+  return shortest_path_tree;
+}
+
+NodeToLabelMap Router::search(NodeID source_node_id, NodeID target_node_id, Weight upper_bound,
+                              const std::vector<Kilometers> &dist_to_target) {
   // All labels in the vector are non-dominating in respect to total_weight and state_of_charge.
   // That is, all labels for a node are Pareto optimal.
   std::unordered_map<NodeID, std::vector<Label>> label_map;
   // Once a NodeID is added to the spt, we know the best Label to use to get to it.
   NodeToLabelMap shortest_path_tree;
+  // Pruning is only possible once a feasible route is known, the bound only ever tightens after.
+  const bool has_upper_bound = upper_bound != NO_UPPER_BOUND;
 
   int label_id = 0;
   MinHeapPriorityQueue label_queue;
@@ -21,10 +66,8 @@ std::string Router::route(std::string source_name, std::string target_name) {
   // std::priority_queue doesn't provide pointers to allow arbitrary deletes of items.
   std::unordered_set<int> deleted_labels;
 
-  NodeID source_node_id = node_name_map_[source_name];
-  NodeID target_node_id = node_name_map_[target_name];
-
   label_queue.emplace(Label(source_node_id, label_id++, 0, 0, MAX_CHARGE, source_node_id));
+  ++stats_.queue_pushes;
   while (!label_queue.empty()) {
     Label curr_label = label_queue.top();
     label_queue.pop();
@@ -45,7 +88,7 @@ std::string Router::route(std::string source_name, std::string target_name) {
       break;
     }
 
-    const Station &curr_station = network_.at(curr_node_id);
+    const MillimetersPerHr &curr_rate = charge_rates_.at(curr_node_id);
 
     // Update weights for all neighbors not in the spt.
     // This is the main departure from standard dijkstra's. Instead of relaxing edges between
@@ -53,13 +96,13 @@ std::string Router::route(std::string source_name, std::string target_name) {
     // LabelMap. Any non-dominated labels are also added to the priority queue.
     for (auto &edge : graph_.at(curr_node_id)) {
       const NodeID &adj_node_id = edge.first;
-      const Kilometers &dist_to_neighbor = edge.second;
+      const Millimeters &dist_to_neighbor = edge.second;
 
       if (shortest_path_tree.count(adj_node_id) == 1) {
         continue;
       }
 
-      Weight direct_weight_to_neighbor = convert_km_to_ms_travel(dist_to_neighbor);
+      Weight direct_weight_to_neighbor = convert_mm_to_ms_travel(dist_to_neighbor);
 
       // Three possible label cases.
       std::vector<Label> labels;
@@ -71,8 +114,7 @@ std::string Router::route(std::string source_name, std::string target_name) {
       }
       // 2. Do a full recharge, if needed.
       if (curr_label.state_of_charge < MAX_CHARGE) {
-        Weight addtl_charge_time =
-            time_to_full_charge(curr_label.state_of_charge, curr_station.rate);
+        Weight addtl_charge_time = time_to_full_charge(curr_label.state_of_charge, curr_rate);
         labels.emplace_back(
             Label(adj_node_id, label_id++,
                   curr_label.total_weight + direct_weight_to_neighbor + addtl_charge_time,
@@ -82,29 +124,50 @@ std::string Router::route(std::string source_name, std::string target_name) {
       if (curr_label.state_of_charge < MAX_CHARGE &&
           curr_label.state_of_charge < dist_to_neighbor) {
         Weight addtl_charge_time =
-            time_to_partial_charge(curr_label.state_of_charge, dist_to_neighbor, curr_station.rate);
+            time_to_partial_charge(curr_label.state_of_charge, dist_to_neighbor, curr_rate);
         labels.emplace_back(
             Label(adj_node_id, label_id++,
                   curr_label.total_weight + direct_weight_to_neighbor + addtl_charge_time,
                   addtl_charge_time, 0, curr_node_id));
       }
 
+      stats_.labels_created += labels.size();
+
+      // Drop labels which cannot beat the best known route to the target, any label which does
+      // reach the target becomes the new best known route.
+      if (has_upper_bound) {
+        labels.erase(std::remove_if(labels.begin(), labels.end(),
+                                    [&](const Label &label) {
+                                      Weight remaining = remaining_weight_lower_bound(
+                                          label, dist_to_target.at(adj_node_id));
+                                      return remaining > upper_bound ||
+                                             label.total_weight > upper_bound - remaining;
+                                    }),
+                     labels.end());
+        if (adj_node_id == target_node_id) {
+          for (auto &label : labels) {
+            upper_bound = std::min(upper_bound, label.total_weight);
+          }
+        }
+      }
+
       // Update this nodes label bag. This is similar to "relaxing" edges in standard Dijkstra's.
-      auto search = label_map.find(adj_node_id);
-      if (search == label_map.end()) {
+      auto bag_it = label_map.find(adj_node_id);
+      if (bag_it == label_map.end()) {
         // No labels exist to dominate these ones, so add them all.
         for (auto &label : labels) {
           label_queue.push(label);
         }
+        stats_.queue_pushes += labels.size();
         label_map[adj_node_id] = std::move(labels);
       } else {
-        std::vector<Label> &bag = search->second;
+        std::vector<Label> &bag = bag_it->second;
 
         for (auto &label : labels) {
-          auto search = std::find_if(bag.begin(), bag.end(),
-                                     [&](const Label &other) { return other.dominates(label); });
+          auto dominator = std::find_if(bag.begin(), bag.end(),
+                                        [&](const Label &other) { return other.dominates(label); });
           // This label is dominated, it can be ignored.
-          if (search != bag.end()) {
+          if (dominator != bag.end()) {
             continue;
           }
 
@@ -117,12 +180,71 @@ std::string Router::route(std::string source_name, std::string target_name) {
           bag.erase(d_it, bag.end());
           bag.push_back(label);
           label_queue.push(label);
+          ++stats_.queue_pushes;
         }
       }
     }
   }
 
-  return build_result_string(shortest_path_tree, source_node_id, target_node_id);
+  return shortest_path_tree;
+}
+
+Weight Router::greedy_upper_bound(NodeID source_node_id, NodeID target_node_id,
+                                  const std::vector<Kilometers> &dist_to_target,
+                                  NodeToLabelMap &greedy_route) {
+  NodeID curr_node_id = source_node_id;
+  Millimeters state_of_charge = MAX_CHARGE;
+  Weight total_weight = 0;
+
+  int label_id = 0;
+  greedy_route.emplace(source_node_id,
+                       Label(source_node_id, label_id++, 0, 0, MAX_CHARGE, source_node_id));
+
+  while (curr_node_id != target_node_id) {
+    // Every edge can be driven on a full charge, and the target is picked whenever it is adjacent.
+    const std::pair<NodeID, Millimeters> *next = nullptr;
+    for (auto &edge : graph_.at(curr_node_id)) {
+      if (next == nullptr || dist_to_target.at(edge.first) < dist_to_target.at(next->first)) {
+        next = &edge;
+      }
+    }
+    // Requiring progress towards the target on every hop guarantees termination.
+    if (next == nullptr || dist_to_target.at(next->first) >= dist_to_target.at(curr_node_id)) {
+      return NO_UPPER_BOUND;
+    }
+
+    Weight charge_time = 0;
+    if (state_of_charge < next->second) {
+      charge_time = time_to_full_charge(state_of_charge, charge_rates_.at(curr_node_id));
+      state_of_charge = MAX_CHARGE;
+    }
+    total_weight += charge_time + convert_mm_to_ms_travel(next->second);
+    state_of_charge -= next->second;
+
+    // Each hop gets closer to the target, so no node is visited twice.
+    greedy_route.emplace(next->first, Label(next->first, label_id++, total_weight, charge_time,
+                                            state_of_charge, curr_node_id));
+    curr_node_id = next->first;
+  }
+
+  return total_weight;
+}
+
+// The remaining route has to drive at least the straight line distance, and has to charge
+// whatever part of it the battery cannot cover at no better than the fastest rate in the network.
+// Real routes sum individually rounded legs, each of which can be up to half a millisecond short of
+// the exact drive or charge time, so one millisecond per possible remaining leg is subtracted.
+Weight Router::remaining_weight_lower_bound(const Label &label, Kilometers dist_to_target_km) {
+  // Rounded down, and capped to fit, so it never exceeds the length of any real route.
+  Millimeters dist_to_target = Millimeters(
+      std::min(dist_to_target_km * MM_IN_KM, double(std::numeric_limits<Millimeters>::max())));
+  Weight lower_bound = convert_mm_to_ms_travel(dist_to_target);
+  if (label.state_of_charge < dist_to_target) {
+    lower_bound += time_to_partial_charge(label.state_of_charge, dist_to_target, max_charge_rate_);
+  }
+
+  Weight rounding_slack = graph_.size() + 1;
+  return lower_bound > rounding_slack ? lower_bound - rounding_slack : 0;
 }
 
 std::string Router::build_result_string(const NodeToLabelMap &shortest_path_tree,
@@ -156,8 +278,9 @@ std::string Router::build_result_string(const NodeToLabelMap &shortest_path_tree
   return result;
 }
 
-Kilometers Router::calculate_travel_km(NodeID source, NodeID dest) {
+Millimeters Router::calculate_travel_mm(NodeID source, NodeID dest) {
   const Station &source_station = network_.at(source);
   const Station &dest_station = network_.at(dest);
-  return haversine_dist(source_station.lat, source_station.lon, dest_station.lat, dest_station.lon);
+  return km_to_mm(
+      haversine_dist(source_station.lat, source_station.lon, dest_station.lat, dest_station.lon));
 }
@@ -1,5 +1,7 @@
 #pragma once
+#include <algorithm>
 #include <cstdint>
+#include <limits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -10,24 +12,43 @@
 
 using NodeToLabelMap = std::unordered_map<NodeID, Label>;
 
+// Used when no feasible route to the target is known, nothing is pruned against it.
+const Weight NO_UPPER_BOUND = std::numeric_limits<Weight>::max();
+
+// Describes the result of, and work done by, the most recent call to Router::route.
+struct SearchStats {
+  Weight route_weight = 0;
+  int labels_created = 0;
+  int queue_pushes = 0;
+};
+
+// Optional search speedups, all disabled by default.
+struct RouterOptions {
+  // Discard labels which cannot reach the target faster than a greedily found feasible route.
+  bool prune_with_upper_bound = false;
+};
+
 class Router {
 public:
   // Constructor builds an adjencey list representing the complete graph minus impossible to reach
-  // nodes.
-  Router(const std::vector<Station> &network) : network_(network) {
-    graph_ = std::vector<std::vector<std::pair<NodeID, Kilometers>>>(
-        network.size(), std::vector<std::pair<NodeID, Kilometers>>());
+  // nodes, plus any preprocessing needed by the enabled options.
+  Router(const std::vector<Station> &network, RouterOptions options = RouterOptions())
+      : network_(network), prune_with_upper_bound_(options.prune_with_upper_bound) {
+    graph_ = std::vector<std::vector<std::pair<NodeID, Millimeters>>>(
+        network.size(), std::vector<std::pair<NodeID, Millimeters>>());
 
     // Created directed graph limited by battery radius.
     for (NodeID i = 0; i < network.size(); ++i) {
       node_name_map_[network_.at(i).name] = i;
+      charge_rates_.push_back(km_hr_to_mm_hr(network_.at(i).rate));
+      max_charge_rate_ = std::max(max_charge_rate_, charge_rates_.back());
 
       for (NodeID j = i + 1; j < network.size(); ++j) {
         if (i == j) {
           exit(1);
         }
-        Kilometers travel_dist = calculate_travel_km(i, j);
-        if (calculate_travel_km(i, j) > MAX_CHARGE) {
+        Millimeters travel_dist = calculate_travel_mm(i, j);
+        if (travel_dist > MAX_CHARGE) {
           continue;
         }
 
@@ -41,6 +62,8 @@ public:
   // a string result showing the route from the source and target provided.
   std::string route(std::string source_name, std::string target_name);
 
+  const SearchStats &last_search_stats() const { return stats_; }
+
 private:
   const std::vector<Station> &network_;
   // Maps a node's geographical string name to a NodeID.
@@ -48,11 +71,37 @@ private:
 
   // Adjacency list representation of network. The network is a complete graph in theory, but
   // some edges can be pruned because not all connections are possible on a full charge.
-  std::vector<std::vector<std::pair<NodeID, Kilometers>>> graph_;
+  std::vector<std::vector<std::pair<NodeID, Millimeters>>> graph_;
+  // Charging rate of each station, indexed by NodeID.
+  std::vector<MillimetersPerHr> charge_rates_;
+  MillimetersPerHr max_charge_rate_ = 0;
+
+  bool prune_with_upper_bound_;
+  SearchStats stats_;
+
+  // Finds a greedy route to bound the search with, then runs the search pruned against it.
+  NodeToLabelMap pruned_search(NodeID source, NodeID target);
+
+  // Runs the label search. Unless upper_bound is NO_UPPER_BOUND, labels which cannot beat it are
+  // discarded using the straight line distances in dist_to_target, and the bound is tightened
+  // whenever a label reaches the target. Returns the shortest path tree, which is missing the
+  // target if every route was pruned.
+  NodeToLabelMap search(NodeID source, NodeID target, Weight upper_bound,
+                        const std::vector<Kilometers> &dist_to_target);
+
+  // Weight of a route found by greedily driving to the neighbor nearest the target and fully
+  // recharging only when the next hop is out of range, or NO_UPPER_BOUND if it gets stuck. The
+  // route is stored in greedy_route in the same form as a shortest path tree.
+  Weight greedy_upper_bound(NodeID source, NodeID target,
+                            const std::vector<Kilometers> &dist_to_target,
+                            NodeToLabelMap &greedy_route);
+
+  // Never overestimates the remaining weight from a label to a target dist_to_target away.
+  Weight remaining_weight_lower_bound(const Label &label, Kilometers dist_to_target_km);
 
   // Traverses the shortest path tree built by routing to create the result output.
   std::string build_result_string(const NodeToLabelMap &shortest_path_tree, NodeID source,
                                   NodeID target);
 
-  Kilometers calculate_travel_km(NodeID, NodeID);
+  Millimeters calculate_travel_mm(NodeID, NodeID);
 };
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cmath>
 #include <ctime>
 #include <fstream>
 #include <string.h>
@@ -7,15 +9,55 @@
 
 #define CLOCKS_PER_MS (CLOCKS_PER_SEC / 1000)
 
+// Accumulates benchmark measurements across queries for a single Router configuration.
+struct BenchResult {
+  std::vector<double> query_times;
+  long labels = 0;
+  long queue_pushes = 0;
+
+  void record(const Router &router, std::clock_t begin, std::clock_t end) {
+    query_times.push_back(double(end - begin) / CLOCKS_PER_MS);
+    labels += router.last_search_stats().labels_created;
+    queue_pushes += router.last_search_stats().queue_pushes;
+  }
+
+  double p99_query_time() const {
+    std::vector<double> sorted_times = query_times;
+    std::sort(sorted_times.begin(), sorted_times.end());
+    return sorted_times.at(size_t(std::ceil(0.99 * sorted_times.size())) - 1);
+  }
+
+  std::string summary(int run_count) const {
+    double total_query_times = 0.0;
+    for (double query_time : query_times) {
+      total_query_times += query_time;
+    }
+
+    return "Total search time: " + std::to_string(total_query_times) +
+           "ms - Average search time: " + std::to_string(total_query_times / double(run_count)) +
+           "ms - p99 search time: " + std::to_string(p99_query_time()) +
+           "ms - Average labels created: " + std::to_string(double(labels) / double(run_count)) +
+           " - Average queue pushes: " + std::to_string(double(queue_pushes) / double(run_count));
+  }
+};
+
 int main(int argc, char **argv) {
   int run_count = 200;
-  Router routing_engine = Router(network);
+  RouterOptions options;
+  options.prune_with_upper_bound = true;
+  Router routing_engine = Router(network, options);
+  // Identical except for upper bound pruning. Used to check that pruning never makes routes worse,
+  // and to report how much work it saves.
+  Router unpruned_engine = Router(network);
 
   std::ofstream file;
   file.open("run_checker.sh");
   file << "#!/bin/bash\n";
 
-  double total_query_times = 0.0;
+  BenchResult pruned_result;
+  BenchResult unpruned_result;
+  int faster_routes = 0;
+  int mismatched_routes = 0;
   for (int i = 0; i < run_count; ++i) {
     int source = std::rand() % network.size();
     int target = std::rand() % network.size();
@@ -29,20 +71,48 @@ int main(int argc, char **argv) {
     std::clock_t begin = std::clock();
     std::string result = routing_engine.route(source_name, target_name);
     std::clock_t end = std::clock();
-    total_query_times += double(end - begin) / CLOCKS_PER_MS;
+    pruned_result.record(routing_engine, begin, end);
+
+    begin = std::clock();
+    std::string unpruned_route = unpruned_engine.route(source_name, target_name);
+    end = std::clock();
+    unpruned_result.record(unpruned_engine, begin, end);
+
+    // Pruning must return the same route, unless it found a strictly faster one.
+    if (result != unpruned_route) {
+      if (routing_engine.last_search_stats().route_weight <
+          unpruned_engine.last_search_stats().route_weight) {
+        ++faster_routes;
+      } else {
+        ++mismatched_routes;
+        std::cerr << "Pruned route differs from unpruned route:\n  " << result << "\n  "
+                  << unpruned_route << std::endl;
+      }
+    }
 
     file << "./reference_linux "
          << "\"" << result << "\"\n";
   }
 
   if (argc == 2 && strcmp(argv[1], "-r") == 0) {
-    file << "echo '# "
-         << "Total search time: " << std::to_string(total_query_times)
-         << "ms - Average search time: " << std::to_string(total_query_times / double(run_count))
-         << "ms"
+    file << "echo '# With upper bound pruning - " << pruned_result.summary(run_count) << "'\n";
+    file << "echo '# Without upper bound pruning - " << unpruned_result.summary(run_count)
          << "'\n";
+    file << "echo '# Upper bound pruning - Queue pushes reduced by: "
+         << std::to_string(100.0 * (1.0 - double(pruned_result.queue_pushes) /
+                                              double(unpruned_result.queue_pushes)))
+         << "% - p99 search time reduced by: "
+         << std::to_string(100.0 * (1.0 - pruned_result.p99_query_time() /
+                                              unpruned_result.p99_query_time()))
+         << "% - Routes faster than without pruning: " << faster_routes << "'\n";
   }
   file.close();
 
+  if (mismatched_routes > 0) {
+    std::cerr << mismatched_routes << " pruned routes differ from the unpruned search"
+              << std::endl;
+    return 1;
+  }
+
   return 0;
 }
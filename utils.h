@@ -1,11 +1,19 @@
 #pragma once
+#include <algorithm>
+#include <cstdint>
+#include <limits>
 #include <math.h>
 
 // Distance types
 using Kilometers = double;
-using Milliseconds = uint64_t;
+using Milliseconds = uint32_t;
 using KmPerHr = double;
 
+// Fixed-point types used by the search. Distances and battery charge are converted once, when the
+// graph is built, so all comparisons during routing are exact and independent of compiler flags.
+using Millimeters = uint32_t;
+using MillimetersPerHr = uint32_t;
+
 // Graph types
 using NodeID = uint16_t;
 using Weight = Milliseconds;
@@ -13,7 +21,9 @@ using Weight = Milliseconds;
 // Constants from the spec
 const double EARTH_RADIUS_KM = 6356.752;
 const double ROAD_SPEED_KM_HR = 105;
-const Kilometers MAX_CHARGE = 320;
+const Millimeters MM_IN_KM = 1000 * 1000;
+const Millimeters MAX_CHARGE = 320 * MM_IN_KM;
+const MillimetersPerHr ROAD_SPEED_MM_HR = MillimetersPerHr(ROAD_SPEED_KM_HR * MM_IN_KM);
 
 const int MS_IN_SEC = 1000;
 const int MS_IN_MINUTE = 60 * MS_IN_SEC;
@@ -40,16 +50,37 @@ inline Kilometers haversine_dist(double lat1, double lng1, double lat2, double l
   return 2.0 * EARTH_RADIUS_KM * computation;
 }
 
-inline Milliseconds convert_km_to_ms_travel(Kilometers distance_km) {
-  return int(((distance_km / ROAD_SPEED_KM_HR) * MS_IN_HOUR) + 0.5);
+// Distances are rounded up to the next whole millimeter, so a route that is feasible in
+// millimeters never runs out of charge when driven with the exact distances. At this resolution
+// the extra charge this adds is far below the millisecond resolution of Weight. Distances across
+// the whole network do not fit in Millimeters and saturate, they are far beyond MAX_CHARGE anyway.
+inline Millimeters km_to_mm(Kilometers distance_km) {
+  return Millimeters(
+      std::min(ceil(distance_km * MM_IN_KM), double(std::numeric_limits<Millimeters>::max())));
+}
+
+// Rates are rounded to the nearest whole millimeter per hour, every station rate is a whole number
+// of km per hour so this is exact in practice.
+inline MillimetersPerHr km_hr_to_mm_hr(KmPerHr rate) {
+  return MillimetersPerHr(rate * MM_IN_KM + 0.5);
+}
+
+// Returns the time to cover distance_mm at rate, rounded to the nearest millisecond.
+inline Milliseconds mm_to_ms(Millimeters distance_mm, MillimetersPerHr rate) {
+  return Milliseconds((uint64_t(distance_mm) * MS_IN_HOUR + rate / 2) / rate);
+}
+
+inline Milliseconds convert_mm_to_ms_travel(Millimeters distance_mm) {
+  return mm_to_ms(distance_mm, ROAD_SPEED_MM_HR);
 }
 
-inline Milliseconds time_to_partial_charge(Kilometers state_of_charge, Kilometers desired_charge,
-                                           KmPerHr rate) {
-  return int((((desired_charge - state_of_charge) / rate) * MS_IN_HOUR) + 0.5);
+// Requires state_of_charge <= desired_charge.
+inline Milliseconds time_to_partial_charge(Millimeters state_of_charge,
+                                           Millimeters desired_charge, MillimetersPerHr rate) {
+  return mm_to_ms(desired_charge - state_of_charge, rate);
 }
 
-inline Milliseconds time_to_full_charge(Kilometers state_of_charge, KmPerHr rate) {
+inline Milliseconds time_to_full_charge(Millimeters state_of_charge, MillimetersPerHr rate) {
   return time_to_partial_charge(state_of_charge, MAX_CHARGE, rate);
 }
 